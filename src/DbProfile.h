@@ -0,0 +1,430 @@
+#ifndef GAMEMATCHER_DBPROFILE_H
+#define GAMEMATCHER_DBPROFILE_H
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadStorage>
+#include <QVector>
+#include <QVariant>
+#include <QtDebug>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "DbUtils.h"
+
+namespace sqlx {
+
+    /**
+     * A set of SQLite connections opened with a consistent tuning preset.
+     *
+     * Writes (insert, update) go to a single writer, which like any QSqlDatabase must only be
+     * used from the thread that opened the profile. Reads (queryList, queryStream, ...) may come
+     * from any thread: each thread lazily gets its own read-only connection with the same tuning,
+     * so reads on different threads run concurrently. A background thread with its own
+     * connection periodically runs "PRAGMA optimize" and a passive WAL checkpoint.
+     *
+     * A thread's reader is closed on that thread when it finishes, when it calls releaseReader(),
+     * or on its next read after the profile has been closed. close() stops handing out readers and
+     * only closes the calling thread's own one, as connections can't be closed from another thread.
+     *
+     * It requires a file-backed database in WAL mode, as ":memory:" isn't shared between connections.
+     */
+    class DbProfile {
+    public:
+        enum Preset {
+            // Large mmap and page cache for read-heavy workloads.
+            ReadMostly,
+            // Large page cache and infrequent auto-checkpoints for sustained writes.
+            BulkIngest,
+            // Huge mmap, small cache and a short busy timeout so callers fail fast instead of queueing.
+            LowLatency
+        };
+
+        struct Tuning {
+            QString journalMode = QStringLiteral("WAL");
+            QString synchronous = QStringLiteral("NORMAL");
+            QString tempStore = QStringLiteral("MEMORY");
+            qint64 mmapSize = 0;
+            // Negative values are in KiB, as per SQLite's cache_size.
+            int cacheSize = -2000;
+            int busyTimeoutMs = 5000;
+            int walAutoCheckpoint = 1000;
+        };
+
+        static inline Tuning tuningFor(Preset preset) {
+            Tuning t;
+            switch (preset) {
+                case ReadMostly:
+                    t.mmapSize = 256LL * 1024 * 1024;
+                    t.cacheSize = -64 * 1024;
+                    break;
+                case BulkIngest:
+                    t.mmapSize = 64LL * 1024 * 1024;
+                    t.cacheSize = -256 * 1024;
+                    t.busyTimeoutMs = 30000;
+                    t.walAutoCheckpoint = 10000;
+                    break;
+                case LowLatency:
+                    t.mmapSize = 1024LL * 1024 * 1024;
+                    t.cacheSize = -16 * 1024;
+                    t.busyTimeoutMs = 100;
+                    break;
+            }
+            return t;
+        }
+
+        inline DbProfile(QString databasePath, const Tuning &tuning,
+                         std::chrono::milliseconds maintenanceInterval = std::chrono::minutes(5))
+                : databasePath(std::move(databasePath)), tuning(tuning), maintenanceInterval(maintenanceInterval) {}
+
+        inline DbProfile(QString databasePath, Preset preset = ReadMostly,
+                         std::chrono::milliseconds maintenanceInterval = std::chrono::minutes(5))
+                : DbProfile(std::move(databasePath), tuningFor(preset), maintenanceInterval) {}
+
+        DbProfile(const DbProfile &) = delete;
+
+        DbProfile &operator=(const DbProfile &) = delete;
+
+        inline ~DbProfile() {
+            close();
+        }
+
+        inline QueryResult<bool> open() {
+            close();
+
+            writerDb = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName(QStringLiteral("writer")));
+            writerDb.setDatabaseName(databasePath);
+            if (!writerDb.open()) {
+                auto e = writerDb.lastError();
+                close();
+                return e;
+            }
+
+            if (auto rc = applyTuning(writerDb, tuning, false); !rc) {
+                close();
+                return rc;
+            }
+
+            auto source = std::make_shared<ReaderSource>();
+            source->databasePath = databasePath;
+            source->tuning = tuning;
+            std::atomic_store(&readerSource, source);
+
+            if (maintenanceInterval.count() > 0) {
+                stopping = false;
+                maintenanceThread = std::thread([this] { runMaintenance(); });
+            }
+            return true;
+        }
+
+        inline bool isOpen() const {
+            return writerDb.isOpen();
+        }
+
+        inline void close() {
+            if (maintenanceThread.joinable()) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping = true;
+                }
+                cv.notify_one();
+                maintenanceThread.join();
+            }
+
+            if (auto source = std::atomic_exchange(&readerSource, std::shared_ptr<ReaderSource>())) {
+                source->enabled = false;
+            }
+            if (threadReaders().hasLocalData()) {
+                threadReaders().localData()->closeIf(&ThreadReaders::isStale);
+            }
+
+            QStringList names;
+            if (writerDb.isValid()) {
+                if (writerDb.isOpen()) {
+                    // The writer doesn't run the reads, so ask optimize to consider every table.
+                    DbUtils::update(writerDb, QStringLiteral("PRAGMA optimize = 0x10002"));
+                }
+                names.append(writerDb.connectionName());
+                writerDb.close();
+            }
+
+            // All copies must be gone before the connections can be removed.
+            writerDb = QSqlDatabase();
+            for (const auto &name : names) {
+                QSqlDatabase::removeDatabase(name);
+            }
+        }
+
+        inline QSqlDatabase &writer() {
+            return writerDb;
+        }
+
+        /**
+         * Returns the calling thread's read-only connection, opening it on first use.
+         */
+        inline QueryResult<QSqlDatabase> reader() {
+            auto source = std::atomic_load(&readerSource);
+            if (!source || !source->enabled) {
+                return QSqlError(QObject::tr("Database profile is not open"));
+            }
+
+            auto &storage = threadReaders();
+            if (!storage.hasLocalData()) {
+                storage.setLocalData(new ThreadReaders);
+            }
+            auto local = storage.localData();
+            local->closeIf(&ThreadReaders::isStale);
+            for (const auto &entry : local->entries) {
+                if (entry.source.lock() == source) {
+                    return entry.db;
+                }
+            }
+
+            static std::atomic<quint64> nextReaderId{0};
+            const auto name = QStringLiteral("sqlx-reader-%1").arg(nextReaderId++);
+            QSqlError error;
+            {
+                auto db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), name);
+                db.setDatabaseName(source->databasePath);
+                db.setConnectOptions(QStringLiteral("QSQLITE_OPEN_READONLY"));
+                if (!db.open()) {
+                    error = db.lastError();
+                } else if (auto rc = applyTuning(db, source->tuning, true); !rc) {
+                    error = *rc.error();
+                    db.close();
+                } else {
+                    local->entries.push_back({source, db});
+                    return db;
+                }
+            }
+            QSqlDatabase::removeDatabase(name);
+            return error;
+        }
+
+        /**
+         * Closes the calling thread's reader before the thread finishes.
+         */
+        inline void releaseReader() {
+            if (!threadReaders().hasLocalData()) return;
+            auto source = std::atomic_load(&readerSource);
+            threadReaders().localData()->closeIf([&](const ThreadReaders::Entry &entry) {
+                return ThreadReaders::isStale(entry) || entry.source.lock() == source;
+            });
+        }
+
+        template<typename ResultType>
+        inline QueryResult<QVector<ResultType>>
+        queryList(const QString &sql, const QVector<QVariant> &binds = {}, const QueryControl &control = {}) {
+            auto db = reader();
+            if (!db) return db.error();
+            return DbUtils::queryList<ResultType>(*db, sql, binds, control);
+        }
+
+        template<typename ResultType>
+        inline QueryResult<ResultType>
+        queryFirst(const QString &sql, const QVector<QVariant> &binds = {}, const QueryControl &control = {}) {
+            auto db = reader();
+            if (!db) return db.error();
+            return DbUtils::queryFirst<ResultType>(*db, sql, binds, control);
+        }
+
+        inline QueryResult<RowArena>
+        queryArena(const QString &sql, const QVector<QVariant> &binds = {}, const QueryControl &control = {}) {
+            auto db = reader();
+            if (!db) return db.error();
+            return DbUtils::queryArena(*db, sql, binds, control);
+        }
+
+        template<typename ResultType, typename Streamer>
+        inline QueryResult<size_t> queryStream(const QString &sql, const QVector<QVariant> &binds, Streamer streamer) {
+            auto db = reader();
+            if (!db) return db.error();
+            return DbUtils::queryStream<ResultType>(*db, sql, binds, streamer);
+        }
+
+        template<typename ResultType, typename Streamer>
+        inline QueryResult<size_t> queryStream(const QString &sql, const QVector<QVariant> &binds,
+                                               const QueryControl &control, Streamer streamer) {
+            auto db = reader();
+            if (!db) return db.error();
+            return DbUtils::queryStream<ResultType>(*db, sql, binds, control, streamer);
+        }
+
+        template<typename Streamer>
+        inline QueryResult<size_t> queryRawStream(const QString &sql, const QVector<QVariant> &binds,
+                                                  Streamer streamer) {
+            auto db = reader();
+            if (!db) return db.error();
+            return DbUtils::queryRawStream(*db, sql, binds, streamer);
+        }
+
+        template<typename Streamer>
+        inline QueryResult<size_t> queryRawStream(const QString &sql, const QVector<QVariant> &binds,
+                                                  const QueryControl &control, Streamer streamer) {
+            auto db = reader();
+            if (!db) return db.error();
+            return DbUtils::queryRawStream(*db, sql, binds, control, streamer);
+        }
+
+        template<typename IdType>
+        inline QueryResult<IdType>
+        insert(const QString &sql, const QVector<QVariant> &binds = {}, const QueryControl &control = {}) {
+            return DbUtils::insert<IdType>(writerDb, sql, binds, control);
+        }
+
+        inline QueryResult<int>
+        update(const QString &sql, const QVector<QVariant> &binds = {}, const QueryControl &control = {}) {
+            return DbUtils::update(writerDb, sql, binds, control);
+        }
+
+    private:
+        struct ReaderSource {
+            QString databasePath;
+            Tuning tuning;
+            std::atomic<bool> enabled{true};
+        };
+
+        // The readers opened on one thread. Owned by QThreadStorage, so it's destroyed on that
+        // thread when it finishes, which is the only place its connections can be closed.
+        struct ThreadReaders {
+            struct Entry {
+                std::weak_ptr<ReaderSource> source;
+                QSqlDatabase db;
+            };
+
+            std::vector<Entry> entries;
+
+            static inline bool isStale(const Entry &entry) {
+                auto source = entry.source.lock();
+                return !source || !source->enabled;
+            }
+
+            template<typename Predicate>
+            inline void closeIf(Predicate predicate) {
+                QStringList names;
+                for (auto it = entries.begin(); it != entries.end();) {
+                    if (predicate(*it)) {
+                        names.append(it->db.connectionName());
+                        it->db.close();
+                        it = entries.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+
+                // All copies must be gone before the connections can be removed.
+                for (const auto &name : names) {
+                    QSqlDatabase::removeDatabase(name);
+                }
+            }
+
+            inline ~ThreadReaders() {
+                closeIf([](const Entry &) { return true; });
+            }
+        };
+
+        static inline QThreadStorage<ThreadReaders *> &threadReaders() {
+            // Deliberately never destroyed: readers of a thread outliving its profile still
+            // have to be closed when that thread finishes.
+            static auto storage = new QThreadStorage<ThreadReaders *>();
+            return *storage;
+        }
+
+        const QString databasePath;
+        const Tuning tuning;
+        const std::chrono::milliseconds maintenanceInterval;
+
+        QSqlDatabase writerDb;
+        // Accessed with std::atomic_load/atomic_store, as readers can be requested from any thread.
+        std::shared_ptr<ReaderSource> readerSource;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool stopping = false;
+        std::thread maintenanceThread;
+
+        inline QString connectionName(const QString &role) const {
+            return QStringLiteral("sqlx-profile-%1-%2")
+                    .arg(reinterpret_cast<quintptr>(this), 0, 16)
+                    .arg(role);
+        }
+
+        static inline QueryResult<bool> applyTuning(QSqlDatabase &db, const Tuning &tuning, bool readOnly) {
+            QStringList pragmas{
+                    QStringLiteral("PRAGMA busy_timeout = %1").arg(tuning.busyTimeoutMs),
+                    QStringLiteral("PRAGMA cache_size = %1").arg(tuning.cacheSize),
+                    QStringLiteral("PRAGMA mmap_size = %1").arg(tuning.mmapSize),
+            };
+            if (!tuning.tempStore.isEmpty()) {
+                pragmas.append(QStringLiteral("PRAGMA temp_store = %1").arg(tuning.tempStore));
+            }
+
+            if (readOnly) {
+                pragmas.append(QStringLiteral("PRAGMA query_only = 1"));
+            } else {
+                if (!tuning.synchronous.isEmpty()) {
+                    pragmas.append(QStringLiteral("PRAGMA synchronous = %1").arg(tuning.synchronous));
+                }
+                pragmas.append(QStringLiteral("PRAGMA wal_autocheckpoint = %1").arg(tuning.walAutoCheckpoint));
+            }
+
+            for (const auto &pragma : pragmas) {
+                if (auto rc = DbUtils::update(db, pragma); !rc) {
+                    return *rc.error();
+                }
+            }
+
+            // The journal mode is persisted in the file, so only the writer sets it. SQLite reports
+            // a failed switch by returning the old mode rather than an error.
+            if (!readOnly && !tuning.journalMode.isEmpty()) {
+                auto mode = DbUtils::queryFirst<QString>(
+                        db, QStringLiteral("PRAGMA journal_mode = %1").arg(tuning.journalMode));
+                if (!mode) return *mode.error();
+                if (mode->compare(tuning.journalMode, Qt::CaseInsensitive) != 0) {
+                    return QSqlError(QObject::tr("Unable to switch journal mode to %1, still in %2")
+                                             .arg(tuning.journalMode, *mode));
+                }
+            }
+            return true;
+        }
+
+        inline void runMaintenance() {
+            // QSqlDatabase connections are bound to the thread that opened them,
+            // so the maintenance thread has its own.
+            const auto name = connectionName(QStringLiteral("maintenance"));
+            {
+                auto db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), name);
+                db.setDatabaseName(databasePath);
+                if (!db.open()) {
+                    qWarning() << "Unable to open maintenance connection: " << db.lastError();
+                } else {
+                    DbUtils::update(db, QStringLiteral("PRAGMA busy_timeout = %1").arg(tuning.busyTimeoutMs));
+
+                    std::unique_lock<std::mutex> lock(mutex);
+                    while (!cv.wait_for(lock, maintenanceInterval, [this] { return stopping; })) {
+                        lock.unlock();
+                        // This connection runs no queries of its own, so ask optimize to consider every table.
+                        DbUtils::update(db, QStringLiteral("PRAGMA optimize = 0x10002"));
+                        DbUtils::update(db, QStringLiteral("PRAGMA wal_checkpoint(PASSIVE)"));
+                        lock.lock();
+                    }
+                    db.close();
+                }
+            }
+            QSqlDatabase::removeDatabase(name);
+        }
+    };
+
+}
+
+#endif //GAMEMATCHER_DBPROFILE_H
@@ -22,6 +22,8 @@
 #include <type_traits>
 
 #include "TypeUtils.h"
+#include "RowArena.h"
+#include "QueryControl.h"
 
 namespace sqlx {
 
@@ -77,8 +79,9 @@ namespace sqlx {
     class DbUtils {
     public:
 
-        template<typename Entity, std::enable_if_t<HasMetaObject<Entity, const QMetaObject>::value, int> = 0>
-        static bool readFrom(Entity &entity, const QSqlRecord &record) {
+        template<typename Entity, typename Record = QSqlRecord,
+                std::enable_if_t<HasMetaObject<Entity, const QMetaObject>::value, int> = 0>
+        static bool readFrom(Entity &entity, const Record &record) {
             static auto propertyMaps = [] {
                 QHash<QString, QMetaProperty> result;
                 const QMetaObject *metaObject = &Entity::staticMetaObject;
@@ -147,8 +150,9 @@ namespace sqlx {
             return true;
         }
 
-        template<typename T, std::enable_if_t<!HasMetaObject<T, const QMetaObject>::value, int> = 0>
-        static bool readFrom(T &out, const QSqlRecord &record) {
+        template<typename T, typename Record = QSqlRecord,
+                std::enable_if_t<!HasMetaObject<T, const QMetaObject>::value, int> = 0>
+        static bool readFrom(T &out, const Record &record) {
             if (auto v = record.value(0); v.convert(qMetaTypeId<T>()) ) {
                 out = v.value<T>();
                 return true;
@@ -158,9 +162,21 @@ namespace sqlx {
             return false;
         }
 
-        static QueryResult<QSqlQuery> buildQuery(QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds) {
+        /**
+         * Prepares and executes the query. The control is checked before exec; to also abort a
+         * running statement, hold a QueryGuard for as long as the returned query is in use.
+         */
+        static QueryResult<QSqlQuery> buildQuery(QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds,
+                                                 const QueryControl &control = {}, bool forwardOnly = false) {
             QueryResult<QSqlQuery> rc;
+            if (auto e = control.check()) {
+                rc.result = *e;
+                return rc;
+            }
+
             QSqlQuery q(db);
+            // Forward-only queries don't keep every fetched row in the driver's result cache.
+            q.setForwardOnly(forwardOnly);
             if (!q.prepare(sql)) {
                 qWarning() << "Error preparing: " << q.lastQuery() << ": " << q.lastError();
                 rc.result = q.lastError();
@@ -172,6 +188,12 @@ namespace sqlx {
             }
 
             if (!q.exec()) {
+                // A statement aborted by the QueryGuard surfaces as a driver error.
+                if (auto e = control.check()) {
+                    rc.result = *e;
+                    return rc;
+                }
+
                 qWarning() << "Error executing: " << q.lastQuery() << ": " << q.lastError();
                 rc.result = q.lastError();
                 return rc;
@@ -181,21 +203,55 @@ namespace sqlx {
             return rc;
         }
 
+        /**
+         * Returns the control's error if fetching ended because the statement was aborted.
+         */
+        static inline std::optional<QSqlError> fetchStopped(const QSqlQuery &query, const QueryControl &control) {
+            if (!query.lastError().isValid()) return std::nullopt;
+            return control.check();
+        }
+
         template<typename ResultType>
         static inline QueryResult<QVector<ResultType>>
-        queryList(QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds = {}) {
-            auto query = buildQuery(db, sql, binds);
+        queryList(QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds = {},
+                  const QueryControl &control = {}) {
+            QueryGuard guard(db, control);
+            auto query = buildQuery(db, sql, binds, control);
             if (!query) return query.error();
             if (!query->isSelect()) return {};
             QVector<ResultType> result;
             result.reserve(query->size());
             while (query->next()) {
+                if (auto e = control.check()) return *e;
                 ResultType r;
                 if (!readFrom(r, query->record())) {
                     return QSqlError(QObject::tr("Unable to read from record"));
                 }
                 result.push_back(r);
             }
+            if (auto e = fetchStopped(*query, control)) return *e;
+            return result;
+        }
+
+        /**
+         * Like queryList, but decodes rows straight into a compact RowArena instead of
+         * building a record and an entity per row. Use readFrom on a row view to get the entity.
+         *
+         * The query is forward-only, so rows aren't also held in the driver's result cache.
+         */
+        static inline QueryResult<RowArena>
+        queryArena(QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds = {},
+                   const QueryControl &control = {}) {
+            QueryGuard guard(db, control);
+            auto query = buildQuery(db, sql, binds, control, true);
+            if (!query) return query.error();
+            if (!query->isSelect()) return {};
+            RowArena result(query->record());
+            while (query->next()) {
+                if (auto e = control.check()) return *e;
+                result.append(*query);
+            }
+            if (auto e = fetchStopped(*query, control)) return *e;
             return result;
         }
 
@@ -203,11 +259,20 @@ namespace sqlx {
         static inline QueryResult<size_t>
         queryStream(QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds,
                     Streamer streamer) {
-            auto query = buildQuery(db, sql, binds);
+            return queryStream<ResultType>(db, sql, binds, QueryControl(), streamer);
+        }
+
+        template<typename ResultType, typename Streamer>
+        static inline QueryResult<size_t>
+        queryStream(QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds,
+                    const QueryControl &control, Streamer streamer) {
+            QueryGuard guard(db, control);
+            auto query = buildQuery(db, sql, binds, control);
             if (!query) return query.error();
             if (!query->isSelect()) return {};
             size_t rc = 0;
             while (query->next()) {
+                if (auto e = control.check()) return *e;
                 ResultType r;
                 if (!readFrom(r, query->record())) {
                     return QSqlError(QObject::tr("Unable to read from record"));
@@ -219,31 +284,43 @@ namespace sqlx {
 
                 rc++;
             }
+            if (auto e = fetchStopped(*query, control)) return *e;
             return rc;
         }
 
         template<typename Streamer>
         static inline QueryResult<size_t> queryRawStream(
                 QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds, Streamer streamer) {
-            auto query = buildQuery(db, sql, binds);
+            return queryRawStream(db, sql, binds, QueryControl(), streamer);
+        }
+
+        template<typename Streamer>
+        static inline QueryResult<size_t> queryRawStream(
+                QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds,
+                const QueryControl &control, Streamer streamer) {
+            QueryGuard guard(db, control);
+            auto query = buildQuery(db, sql, binds, control);
             if (!query) return query.error();
             if (!query->isSelect()) return {};
             size_t rc = 0;
             while (query->next()) {
+                if (auto e = control.check()) return *e;
                 if (!streamer(query->record())) {
                     break;
                 }
 
                 rc++;
             }
+            if (auto e = fetchStopped(*query, control)) return *e;
             return rc;
         }
 
 
         template<typename ResultType>
         static inline QueryResult<ResultType>
-        queryFirst(QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds = {}) {
-            auto result = queryList<ResultType>(db, sql, binds);
+        queryFirst(QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds = {},
+                   const QueryControl &control = {}) {
+            auto result = queryList<ResultType>(db, sql, binds, control);
             if (!result) return result.error();
             if (result->isEmpty()) {
                 return QSqlError(QObject::tr("Empty data set"));
@@ -253,8 +330,10 @@ namespace sqlx {
 
         template<typename IdType>
         static inline QueryResult<IdType>
-        insert(QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds = {}) {
-            auto query = buildQuery(db, sql, binds);
+        insert(QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds = {},
+               const QueryControl &control = {}) {
+            QueryGuard guard(db, control);
+            auto query = buildQuery(db, sql, binds, control);
             if (!query) return query.error();
             if (auto id = query->lastInsertId(); id.isValid()) {
                 return id.value<IdType>();
@@ -263,8 +342,10 @@ namespace sqlx {
         }
 
         static inline QueryResult<int>
-        update(QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds = {}) {
-            auto query = buildQuery(db, sql, binds);
+        update(QSqlDatabase &db, const QString &sql, const QVector<QVariant> &binds = {},
+               const QueryControl &control = {}) {
+            QueryGuard guard(db, control);
+            auto query = buildQuery(db, sql, binds, control);
             if (!query) return query.error();
             return query->numRowsAffected();
         }
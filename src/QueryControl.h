@@ -0,0 +1,155 @@
+#ifndef GAMEMATCHER_QUERYCONTROL_H
+#define GAMEMATCHER_QUERYCONTROL_H
+
+#include <QDeadlineTimer>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QObject>
+#include <QVariant>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+
+#ifdef SQLX_HAS_SQLITE3
+#include <sqlite3.h>
+#endif
+
+namespace sqlx {
+
+    /**
+     * A thread-safe flag that can be shared with a running query to cancel it.
+     * Copies refer to the same flag.
+     */
+    class CancellationToken {
+        std::shared_ptr<std::atomic<bool>> state = std::make_shared<std::atomic<bool>>(false);
+
+    public:
+        inline void cancel() const { state->store(true, std::memory_order_relaxed); }
+
+        inline bool isCancelled() const { return state->load(std::memory_order_relaxed); }
+    };
+
+    /**
+     * Per-call cancellation and deadline. It's checked between rows during fetch, and
+     * within a running statement through a QueryGuard where the driver supports it.
+     */
+    struct QueryControl {
+        std::optional<CancellationToken> token;
+        QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever);
+
+        static inline QueryControl withTimeout(qint64 msecs, std::optional<CancellationToken> token = std::nullopt) {
+            return QueryControl{std::move(token), QDeadlineTimer(msecs)};
+        }
+
+        inline bool isActive() const {
+            return token || !deadline.isForever();
+        }
+
+        inline bool isStopped() const {
+            return (token && token->isCancelled()) || deadline.hasExpired();
+        }
+
+        inline std::optional<QSqlError> check() const {
+            if (token && token->isCancelled()) {
+                return QSqlError(QObject::tr("Query cancelled"), QString(),
+                                 QSqlError::StatementError, QStringLiteral("SQLX_CANCELLED"));
+            }
+            if (deadline.hasExpired()) {
+                return QSqlError(QObject::tr("Query timed out"), QString(),
+                                 QSqlError::StatementError, QStringLiteral("SQLX_TIMEOUT"));
+            }
+            return std::nullopt;
+        }
+
+        static inline bool isCancelledError(const QSqlError &e) {
+            return e.nativeErrorCode() == QLatin1String("SQLX_CANCELLED");
+        }
+
+        static inline bool isTimeoutError(const QSqlError &e) {
+            return e.nativeErrorCode() == QLatin1String("SQLX_TIMEOUT");
+        }
+    };
+
+    /**
+     * Installs a SQLite progress handler on the connection for as long as it's alive, so a
+     * statement stepping on this connection is aborted once the control is cancelled or expired.
+     * Only the statement being stepped is aborted; other statements on the connection aren't affected.
+     *
+     * Guards nest: an inner call on the same connection takes over the handler and restores the
+     * enclosing call's handler when it finishes. Connections are thread-bound, so the chain is per thread.
+     *
+     * This is only available for QSQLITE when configured with SQLX_WITH_SYSTEM_SQLITE; otherwise
+     * it's a no-op and the control is only honoured between rows.
+     */
+    class QueryGuard {
+#ifdef SQLX_HAS_SQLITE3
+        sqlite3 *handle = nullptr;
+        const QueryControl *control = nullptr;
+        QueryGuard *previous = nullptr;
+
+        // Number of virtual machine instructions between checks.
+        static constexpr int kProgressOps = 1000;
+
+        static inline QueryGuard *&current() {
+            static thread_local QueryGuard *guard = nullptr;
+            return guard;
+        }
+
+        static inline int onProgress(void *data) {
+            return static_cast<const QueryControl *>(data)->isStopped() ? 1 : 0;
+        }
+
+        inline void install() const {
+            sqlite3_progress_handler(handle, kProgressOps, &onProgress,
+                                     const_cast<QueryControl *>(control));
+        }
+#endif
+
+    public:
+        inline QueryGuard(const QSqlDatabase &db, const QueryControl &control) {
+#ifdef SQLX_HAS_SQLITE3
+            if (!control.isActive()) return;
+            auto driver = db.driver();
+            if (!driver) return;
+            QVariant v = driver->handle();
+            if (!v.isValid() || qstrcmp(v.typeName(), "sqlite3*") != 0) return;
+            handle = *static_cast<sqlite3 **>(v.data());
+            if (!handle) return;
+
+            this->control = &control;
+            previous = current();
+            current() = this;
+            install();
+#else
+            Q_UNUSED(db);
+            Q_UNUSED(control);
+#endif
+        }
+
+        QueryGuard(const QueryGuard &) = delete;
+
+        QueryGuard &operator=(const QueryGuard &) = delete;
+
+        inline ~QueryGuard() {
+#ifdef SQLX_HAS_SQLITE3
+            if (!handle) return;
+            current() = previous;
+
+            auto outer = previous;
+            while (outer && outer->handle != handle) {
+                outer = outer->previous;
+            }
+            if (outer) {
+                outer->install();
+            } else {
+                sqlite3_progress_handler(handle, 0, nullptr, nullptr);
+            }
+#endif
+        }
+    };
+
+}
+
+#endif //GAMEMATCHER_QUERYCONTROL_H
@@ -0,0 +1,308 @@
+#ifndef GAMEMATCHER_ROWARENA_H
+#define GAMEMATCHER_ROWARENA_H
+
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QString>
+#include <QStringView>
+#include <QByteArray>
+#include <QVariant>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+#include <cstring>
+
+namespace sqlx {
+
+    /**
+     * A compact, read-only store of query results.
+     *
+     * Fixed-width values live inline in chunked cell arrays, while string and blob data
+     * are appended to shared slabs. Rows are exposed as lightweight RowView, which can be
+     * converted to a full entity on demand via DbUtils::readFrom.
+     *
+     * The last chunk and the shared slabs start small and grow geometrically, so small results
+     * stay small. Copies of a RowArena share the same underlying storage, including rows appended later.
+     */
+    class RowArena {
+        struct Cell {
+            enum Kind : quint8 {
+                Null, Integer, Unsigned, Double, Bool, String, Blob, Variant
+            };
+
+            union {
+                qint64 i;
+                quint64 u;
+                double d;
+                struct {
+                    quint32 slab;
+                    quint32 offset;
+                } ref;
+            };
+            quint32 length;
+            quint16 metaType;
+            Kind kind;
+        };
+
+        struct Slab {
+            std::unique_ptr<char[]> bytes;
+            quint32 used;
+            quint32 capacity;
+        };
+
+    public:
+        // Rows per chunk once a chunk has fully grown.
+        static constexpr int kRowsPerChunk = 1024;
+        static constexpr int kInitialChunkRows = 16;
+        // Largest shared slab; values over a quarter of it get a slab of their own.
+        static constexpr quint32 kSlabSize = 64 * 1024;
+        static constexpr quint32 kInitialSlabSize = 1024;
+
+    private:
+        struct Data {
+            QVector<QString> columns;
+            std::vector<std::unique_ptr<Cell[]>> chunks;
+            // Capacity in rows of the last chunk.
+            int lastChunkRows = 0;
+            std::vector<Slab> slabs;
+            int currentSlab = -1;
+            QVector<QVariant> variants;
+            int rows = 0;
+        };
+
+        std::shared_ptr<Data> d = std::make_shared<Data>();
+
+    public:
+        class RowView {
+            const Data *d;
+            int row;
+
+            inline const Cell &cell(int col) const {
+                return d->chunks[row / kRowsPerChunk][(row % kRowsPerChunk) * d->columns.size() + col];
+            }
+
+            inline const char *bytes(const Cell &c) const {
+                return d->slabs[c.ref.slab].bytes.get() + c.ref.offset;
+            }
+
+        public:
+            inline RowView(const Data *d, int row) : d(d), row(row) {}
+
+            inline int count() const { return d->columns.size(); }
+
+            inline QString fieldName(int col) const { return d->columns.value(col); }
+
+            inline bool isNull(int col) const { return cell(col).kind == Cell::Null; }
+
+            /**
+             * Returns the string at the given column without copying. The view stays valid
+             * as long as the arena it came from is alive. Non-string columns yield a null view.
+             */
+            inline QStringView stringView(int col) const {
+                const auto &c = cell(col);
+                if (c.kind != Cell::String) return {};
+                return QStringView(reinterpret_cast<const QChar *>(bytes(c)), c.length);
+            }
+
+            /**
+             * Returns the blob at the given column without copying, see stringView for lifetime.
+             */
+            inline QByteArray blob(int col) const {
+                const auto &c = cell(col);
+                if (c.kind != Cell::Blob) return {};
+                return QByteArray::fromRawData(bytes(c), c.length);
+            }
+
+            inline QVariant value(int col) const {
+                const auto &c = cell(col);
+                QVariant rc;
+                switch (c.kind) {
+                    case Cell::Null:
+                        return QVariant(static_cast<QVariant::Type>(c.metaType));
+                    case Cell::Integer:
+                        rc = static_cast<qlonglong>(c.i);
+                        break;
+                    case Cell::Unsigned:
+                        rc = static_cast<qulonglong>(c.u);
+                        break;
+                    case Cell::Double:
+                        rc = c.d;
+                        break;
+                    case Cell::Bool:
+                        rc = c.i != 0;
+                        break;
+                    case Cell::String:
+                        return QString(reinterpret_cast<const QChar *>(bytes(c)), c.length);
+                    case Cell::Blob:
+                        return QByteArray(bytes(c), c.length);
+                    case Cell::Variant:
+                        return d->variants.at(c.ref.offset);
+                }
+
+                if (rc.userType() != c.metaType) {
+                    rc.convert(c.metaType);
+                }
+                return rc;
+            }
+        };
+
+        inline int rowCount() const { return d->rows; }
+
+        inline int columnCount() const { return d->columns.size(); }
+
+        inline bool isEmpty() const { return d->rows == 0; }
+
+        inline QString fieldName(int col) const { return d->columns.value(col); }
+
+        inline int indexOf(const QString &name) const { return d->columns.indexOf(name); }
+
+        inline RowView row(int i) const {
+            Q_ASSERT(i >= 0 && i < d->rows);
+            return RowView(d.get(), i);
+        }
+
+        inline RowView operator[](int i) const { return row(i); }
+
+        inline RowArena() = default;
+
+        /**
+         * Creates an empty arena with the columns of the given record.
+         */
+        inline explicit RowArena(const QSqlRecord &record) {
+            d->columns.resize(record.count());
+            for (int i = 0; i < record.count(); i++) {
+                d->columns[i] = record.fieldName(i);
+            }
+        }
+
+        /**
+         * Appends a row from anything with value(int), such as a QSqlQuery positioned on a row or a QSqlRecord.
+         */
+        template<typename Record>
+        inline void append(const Record &record) {
+            Cell *cells = nextRow();
+            for (int i = 0, columns = d->columns.size(); i < columns; i++) {
+                storeValue(cells[i], record.value(i));
+            }
+            d->rows++;
+        }
+
+    private:
+        // Cells are written before they're read, so they're left uninitialised rather than zero-filled.
+        static inline std::unique_ptr<Cell[]> allocateCells(int rows, int columns) {
+            return std::unique_ptr<Cell[]>(new Cell[static_cast<size_t>(rows) * columns]);
+        }
+
+        inline Cell *nextRow() {
+            const int columns = d->columns.size();
+            const int chunkRow = d->rows % kRowsPerChunk;
+            if (chunkRow == 0) {
+                // Only the first chunk starts small; once a chunk has filled up the result is large anyway.
+                d->lastChunkRows = d->chunks.empty() ? kInitialChunkRows : kRowsPerChunk;
+                d->chunks.push_back(allocateCells(d->lastChunkRows, columns));
+            } else if (chunkRow == d->lastChunkRows) {
+                const int rows = qMin(d->lastChunkRows * 2, kRowsPerChunk);
+                auto grown = allocateCells(rows, columns);
+                std::memcpy(grown.get(), d->chunks.back().get(),
+                            static_cast<size_t>(chunkRow) * columns * sizeof(Cell));
+                d->chunks.back() = std::move(grown);
+                d->lastChunkRows = rows;
+            }
+            return d->chunks.back().get() + static_cast<size_t>(chunkRow) * columns;
+        }
+
+        inline void store(Cell &c, const char *data, quint32 size, quint32 align) {
+            // Large values get their own slab so they don't waste the tail of the shared one.
+            if (size > kSlabSize / 4) {
+                Slab slab{std::unique_ptr<char[]>(new char[size]), size, size};
+                std::memcpy(slab.bytes.get(), data, size);
+                c.ref.slab = static_cast<quint32>(d->slabs.size());
+                c.ref.offset = 0;
+                d->slabs.push_back(std::move(slab));
+                return;
+            }
+
+            quint32 offset = 0;
+            if (d->currentSlab >= 0) {
+                const auto &current = d->slabs[d->currentSlab];
+                offset = (current.used + align - 1) / align * align;
+            }
+
+            if (d->currentSlab < 0 || offset + size > d->slabs[d->currentSlab].capacity) {
+                quint32 capacity = d->currentSlab < 0
+                                   ? kInitialSlabSize
+                                   : qMin(d->slabs[d->currentSlab].capacity * 2, kSlabSize);
+                capacity = qMax(capacity, size);
+                d->slabs.push_back(Slab{std::unique_ptr<char[]>(new char[capacity]), 0, capacity});
+                d->currentSlab = static_cast<int>(d->slabs.size()) - 1;
+                offset = 0;
+            }
+
+            auto &slab = d->slabs[d->currentSlab];
+            std::memcpy(slab.bytes.get() + offset, data, size);
+            slab.used = offset + size;
+            c.ref.slab = static_cast<quint32>(d->currentSlab);
+            c.ref.offset = offset;
+        }
+
+        inline void storeValue(Cell &c, const QVariant &v) {
+            c.metaType = static_cast<quint16>(v.userType());
+            c.length = 0;
+
+            if (v.isNull()) {
+                c.kind = Cell::Null;
+                return;
+            }
+
+            switch (v.userType()) {
+                case QMetaType::Int:
+                case QMetaType::LongLong:
+                case QMetaType::Short:
+                case QMetaType::Long:
+                    c.kind = Cell::Integer;
+                    c.i = v.toLongLong();
+                    break;
+                case QMetaType::UInt:
+                case QMetaType::ULongLong:
+                case QMetaType::UShort:
+                case QMetaType::ULong:
+                    c.kind = Cell::Unsigned;
+                    c.u = v.toULongLong();
+                    break;
+                case QMetaType::Double:
+                case QMetaType::Float:
+                    c.kind = Cell::Double;
+                    c.d = v.toDouble();
+                    break;
+                case QMetaType::Bool:
+                    c.kind = Cell::Bool;
+                    c.i = v.toBool();
+                    break;
+                case QMetaType::QString: {
+                    const auto str = v.toString();
+                    c.kind = Cell::String;
+                    c.length = static_cast<quint32>(str.size());
+                    store(c, reinterpret_cast<const char *>(str.constData()),
+                          c.length * sizeof(QChar), alignof(QChar));
+                    break;
+                }
+                case QMetaType::QByteArray: {
+                    const auto bytes = v.toByteArray();
+                    c.kind = Cell::Blob;
+                    c.length = static_cast<quint32>(bytes.size());
+                    store(c, bytes.constData(), c.length, 1);
+                    break;
+                }
+                default:
+                    c.kind = Cell::Variant;
+                    c.ref.offset = static_cast<quint32>(d->variants.size());
+                    d->variants.append(v);
+                    break;
+            }
+        }
+    };
+
+}
+
+#endif //GAMEMATCHER_ROWARENA_H
@@ -0,0 +1,117 @@
+#include <QTemporaryDir>
+#include <QObject>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "DbProfile.h"
+
+#include <catch2/catch.hpp>
+
+struct ProfileObject {
+Q_GADGET
+public:
+
+    int id = 0;
+    Q_PROPERTY(int id MEMBER id);
+
+    QString name;
+    Q_PROPERTY(QString name MEMBER name);
+};
+
+TEST_CASE("Should apply tuning presets") {
+    auto preset = GENERATE(sqlx::DbProfile::ReadMostly, sqlx::DbProfile::BulkIngest, sqlx::DbProfile::LowLatency);
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+
+    sqlx::DbProfile profile(dir.filePath("test.db"), preset, std::chrono::milliseconds(0));
+    REQUIRE(profile.open());
+
+    CHECK(sqlx::DbUtils::queryFirst<QString>(profile.writer(), "PRAGMA journal_mode").orDefault() == "wal");
+    CHECK(sqlx::DbUtils::queryFirst<int>(profile.writer(), "PRAGMA synchronous").orDefault(-1) == 1);
+
+    auto reader = profile.reader();
+    REQUIRE(reader);
+    CHECK(sqlx::DbUtils::queryFirst<qint64>(*reader, "PRAGMA mmap_size").orDefault(-1) ==
+          sqlx::DbProfile::tuningFor(preset).mmapSize);
+}
+
+TEST_CASE("Should fail to open when WAL can't be enabled") {
+    sqlx::DbProfile profile(":memory:", sqlx::DbProfile::ReadMostly, std::chrono::milliseconds(0));
+    CHECK(!profile.open());
+    CHECK(!profile.isOpen());
+}
+
+TEST_CASE("Should route reads to readers and writes to the writer") {
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+
+    sqlx::DbProfile profile(dir.filePath("test.db"), sqlx::DbProfile::ReadMostly, std::chrono::milliseconds(10));
+    REQUIRE(profile.open());
+
+    REQUIRE(profile.update("create table tests (id integer primary key, name text)"));
+    for (int i = 1; i <= 5; i++) {
+        REQUIRE(profile.insert<int>("insert into tests (id, name) values (?, ?)", {i, QStringLiteral("Name %1").arg(i)}));
+    }
+
+    auto actual = profile.queryList<ProfileObject>("select * from tests order by id asc");
+    REQUIRE(actual.success());
+    REQUIRE(actual->size() == 5);
+    CHECK(actual->at(4).name == "Name 5");
+
+    size_t streamed = 0;
+    auto rc = profile.queryStream<ProfileObject>("select * from tests", {}, [&](auto &) {
+        streamed++;
+        return true;
+    });
+    CHECK(rc.toOptional() == std::optional<size_t>(5));
+    CHECK(streamed == 5);
+
+    // Readers are read-only.
+    auto reader = profile.reader();
+    REQUIRE(reader);
+    CHECK(!sqlx::DbUtils::update(*reader, "delete from tests"));
+
+    SECTION("concurrent reads") {
+        const auto readerConnections = [] {
+            const auto names = QSqlDatabase::connectionNames();
+            return std::count_if(names.begin(), names.end(), [](const QString &name) {
+                return name.startsWith(QLatin1String("sqlx-reader-"));
+            });
+        };
+        const auto readersBefore = readerConnections();
+
+        constexpr int threadCount = 4;
+        constexpr int queriesPerThread = 50;
+        std::atomic<int> succeeded{0};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < threadCount; i++) {
+            threads.emplace_back([&, i] {
+                for (int j = 0; j < queriesPerThread; j++) {
+                    auto rows = profile.queryList<ProfileObject>("select * from tests where id > ?", {j % 5});
+                    if (rows && rows->size() == 5 - j % 5) succeeded++;
+                }
+                // The other threads rely on their readers being closed when they finish.
+                if (i % 2 == 0) profile.releaseReader();
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        CHECK(succeeded == threadCount * queriesPerThread);
+        CHECK(readerConnections() == readersBefore);
+
+        // Closing only closes this thread's reader, and stops handing out new ones.
+        profile.close();
+        CHECK(readerConnections() == 0);
+    }
+
+    profile.close();
+    CHECK(!profile.isOpen());
+    CHECK(!profile.queryList<ProfileObject>("select * from tests"));
+}
+
+#include "DbProfileTest.moc"
@@ -36,6 +36,23 @@ public:
     }
 };
 
+struct ArenaObject {
+Q_GADGET
+public:
+
+    int id = 0;
+    Q_PROPERTY(int id MEMBER id);
+
+    QString name;
+    Q_PROPERTY(QString name MEMBER name);
+
+    double score = 0;
+    Q_PROPERTY(double score MEMBER score);
+
+    QByteArray data;
+    Q_PROPERTY(QByteArray data MEMBER data);
+};
+
 inline void updateRecord(QSqlRecord &record) {
 }
 
@@ -243,6 +260,93 @@ TEST_CASE("Should perform correct database operations") {
         CHECK(actualResult.toOptional() == successExpected);
     }
 
+    SECTION("queryArena") {
+        REQUIRE(sqlx::DbUtils::insert<int>(db, "insert into tests (id, name) values (?, null)", {1000}));
+
+        auto actual = sqlx::DbUtils::queryArena(db, "select id, name from tests order by id asc");
+        REQUIRE(actual.success());
+        REQUIRE(actual->rowCount() == inputs.size() + 1);
+        CHECK(actual->columnCount() == 2);
+        CHECK(actual->indexOf("name") == 1);
+
+        for (int i = 0; i < inputs.size(); i++) {
+            auto row = actual->row(i);
+            CHECK(row.value(0).toInt() == inputs[i].id);
+            CHECK(row.stringView(1) == inputs[i].name);
+
+            TestObject obj;
+            REQUIRE(sqlx::DbUtils::readFrom(obj, row));
+            CHECK(obj == inputs[i]);
+        }
+
+        auto last = actual->row(inputs.size());
+        CHECK(last.isNull(1));
+        CHECK(last.stringView(1).isNull());
+
+        CHECK(!sqlx::DbUtils::queryArena(db, "select * from tests2"));
+
+        auto forwardOnly = sqlx::DbUtils::buildQuery(db, "select id, name from tests", {}, {}, true);
+        REQUIRE(forwardOnly.success());
+        CHECK(forwardOnly->isForwardOnly());
+        CHECK(!sqlx::DbUtils::buildQuery(db, "select id, name from tests", {})->isForwardOnly());
+    }
+
+    SECTION("query control") {
+        sqlx::CancellationToken token;
+        sqlx::QueryControl control{token};
+
+        QVector<TestObject> output;
+        auto streamed = sqlx::DbUtils::queryStream<TestObject>(
+                db, "select * from tests order by id asc", {}, control, [&](auto &obj) {
+                    output.append(obj);
+                    if (output.size() == 3) token.cancel();
+                    return true;
+                });
+        REQUIRE(streamed.error());
+        CHECK(sqlx::QueryControl::isCancelledError(*streamed.error()));
+        CHECK(output == inputs.mid(0, 3));
+
+        auto cancelled = sqlx::DbUtils::queryList<TestObject>(db, "select * from tests", {}, control);
+        REQUIRE(cancelled.error());
+        CHECK(sqlx::QueryControl::isCancelledError(*cancelled.error()));
+
+        auto expired = sqlx::DbUtils::queryList<TestObject>(db, "select * from tests", {},
+                                                            sqlx::QueryControl::withTimeout(0));
+        REQUIRE(expired.error());
+        CHECK(sqlx::QueryControl::isTimeoutError(*expired.error()));
+
+#ifdef SQLX_HAS_SQLITE3
+        auto interrupted = sqlx::DbUtils::queryFirst<int>(
+                db, "with recursive c(x) as (select 1 union all select x + 1 from c) select count(*) from c", {},
+                sqlx::QueryControl::withTimeout(50));
+        REQUIRE(interrupted.error());
+        CHECK(sqlx::QueryControl::isTimeoutError(*interrupted.error()));
+
+        // The first row comes back from exec, the slow scan happens while fetching the next one.
+        size_t fetched = 0;
+        auto slowFetch = sqlx::DbUtils::queryRawStream(
+                db, "with recursive c(x) as (select 1 union all select x + 1 from c) "
+                    "select x from c where x = 1 or x < 0", {},
+                sqlx::QueryControl::withTimeout(50), [&](const QSqlRecord &) {
+                    fetched++;
+                    return true;
+                });
+        REQUIRE(slowFetch.error());
+        CHECK(sqlx::QueryControl::isTimeoutError(*slowFetch.error()));
+        CHECK(fetched == 1);
+
+        // An inner call timing out must not abort the enclosing stream on the same connection.
+        auto outer = sqlx::DbUtils::queryStream<TestObject>(
+                db, "select * from tests order by id asc limit 5", {}, [&](auto &) {
+                    auto inner = sqlx::DbUtils::queryFirst<int>(
+                            db, "with recursive c(x) as (select 1 union all select x + 1 from c) select count(*) from c",
+                            {}, sqlx::QueryControl::withTimeout(10));
+                    return inner.error() && sqlx::QueryControl::isTimeoutError(*inner.error());
+                });
+        CHECK(outer.toOptional() == std::optional<size_t>(5));
+#endif
+    }
+
     SECTION("queryFirst POD") {
         auto[sql, binds, expected] = GENERATE_COPY(table<QString, QVector<QVariant>, std::optional<TestObject>>(
                 {
@@ -335,4 +439,80 @@ TEST_CASE("Should perform correct database operations") {
 }
 
 
+TEST_CASE("Should lay out query results in a RowArena") {
+    auto db = QSqlDatabase::addDatabase("QSQLITE", "arena");
+    db.setDatabaseName(":memory:");
+    REQUIRE(db.open());
+    REQUIRE(sqlx::DbUtils::update(db, "create table arena (id integer primary key, name text, score real, data blob)"));
+
+    // Enough rows to grow the first chunk and spill into a second one.
+    const int rowCount = sqlx::RowArena::kRowsPerChunk + sqlx::RowArena::kInitialChunkRows * 3 + 7;
+    const int bigRow = 5, nullRow = 9;
+    REQUIRE(db.transaction());
+    for (int i = 1; i <= rowCount; i++) {
+        QVariant name = QStringLiteral("Name %1 ").arg(i).repeated(8);
+        if (i == bigRow) {
+            // Larger than a quarter of a slab, so it gets a slab of its own.
+            name = QString(static_cast<int>(sqlx::RowArena::kSlabSize / sizeof(QChar)), QLatin1Char('x'));
+        } else if (i == nullRow) {
+            name = QVariant(QVariant::String);
+        }
+        QByteArray data = QByteArray::number(i);
+        data.append('\0').append("blob");
+        REQUIRE(sqlx::DbUtils::insert<int>(db, "insert into arena (id, name, score, data) values (?, ?, ?, ?)",
+                                           {i, name, i * 0.25, data}));
+    }
+    REQUIRE(db.commit());
+
+    const QString sql = "select id, name, score, data from arena order by id asc";
+    auto expected = sqlx::DbUtils::queryList<ArenaObject>(db, sql);
+    REQUIRE(expected.success());
+    REQUIRE(expected->size() == rowCount);
+
+    auto actual = sqlx::DbUtils::queryArena(db, sql);
+    REQUIRE(actual.success());
+    REQUIRE(actual->rowCount() == rowCount);
+    REQUIRE(actual->columnCount() == 4);
+
+    for (int i = 0; i < rowCount; i++) {
+        const auto &obj = expected->at(i);
+        auto row = actual->row(i);
+        CHECK(row.value(0).toInt() == obj.id);
+        CHECK(row.value(1).toString() == obj.name);
+        CHECK(row.stringView(1) == obj.name);
+        CHECK(row.isNull(1) == (obj.id == nullRow));
+        CHECK(row.value(2).toDouble() == obj.score);
+        CHECK(row.value(3).toByteArray() == obj.data);
+        CHECK(row.blob(3) == obj.data);
+        CHECK(row.blob(1).isNull());
+        CHECK(row.stringView(3).isNull());
+
+        ArenaObject fromRow;
+        REQUIRE(sqlx::DbUtils::readFrom(fromRow, row));
+        CHECK(fromRow.id == obj.id);
+        CHECK(fromRow.name == obj.name);
+        CHECK(fromRow.score == obj.score);
+        CHECK(fromRow.data == obj.data);
+    }
+
+    SECTION("values without an inline layout") {
+        const auto when = QDateTime::fromSecsSinceEpoch(1600000000, QTimeZone::utc());
+        const auto record = createRecord("when", when, "name", QStringLiteral("Name"));
+
+        sqlx::RowArena arena(record);
+        arena.append(record);
+        REQUIRE(arena.rowCount() == 1);
+        CHECK(arena.fieldName(0) == "when");
+
+        auto row = arena.row(0);
+        CHECK(row.value(0).userType() == QMetaType::QDateTime);
+        CHECK(row.value(0) == record.value(0));
+        CHECK(row.stringView(0).isNull());
+        CHECK(row.blob(0).isNull());
+        CHECK(row.stringView(1) == record.value(1).toString());
+    }
+
+    db.close();
+}
+
 #include "DbUtilsTest.moc"
\ No newline at end of file